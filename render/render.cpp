@@ -0,0 +1,466 @@
+// Headless offline renderer for the sand simulation.
+//
+// Builds src/main.cpp against the host stand-ins in render/shim, drives loop()
+// from a virtual clock as fast as the host allows, and writes every frame shown
+// as true X/Y pixels (the panel layout is undone through getCrgb()).
+//
+// Parameters given as a comma separated list are swept: every combination is
+// rendered, each in its own process (the simulation state lives in globals),
+// with up to --jobs of them running at once.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++17 -Irender/shim render/render.cpp -o sand-render
+//   ./sand-render --frames=2000 --maxVelocity=1,2,3 --gravityDirection=S,E
+//   ffmpeg -f image2pipe -c:v ppm -framerate 20 -i sand_maxVelocity-2_gravityDirection-S.ppm out.mp4
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../src/main.cpp"
+
+//////////////////////////////////////////
+// Virtual clock and frame output
+
+static unsigned long virtualMillis = 0;
+
+unsigned long millis()
+{
+  return virtualMillis;
+}
+
+struct RenderOptions
+{
+  unsigned long frames = 1200;
+  unsigned long every = 1;
+  uint16_t scale = 8;
+  uint16_t gain = 1;
+  long jobs = 0;
+  unsigned int seed = 1;
+  std::string out = ".";
+  bool raw = false;
+};
+
+static RenderOptions options;
+
+static FILE *frameOut = NULL;
+static unsigned long framesShown = 0;
+static unsigned long framesWritten = 0;
+static std::vector<uint8_t> frameBuffer;
+
+static void writeFrame()
+{
+  const uint16_t width = COLS * options.scale;
+  const uint16_t height = ROWS * options.scale;
+  frameBuffer.resize(size_t(width) * height * 3);
+
+  for (uint16_t y = 0; y < ROWS; ++y)
+  {
+    uint8_t *row = &frameBuffer[size_t(y) * options.scale * width * 3];
+
+    for (uint16_t x = 0; x < COLS; ++x)
+    {
+      CRGB *crgb = getCrgb(x, y);
+
+      // Scale the whole pixel, capped where its brightest channel reaches 255, so the hue is kept.
+      uint16_t brightest = max(crgb->raw[0], max(crgb->raw[1], crgb->raw[2]));
+      uint16_t scaledBrightest = min<uint16_t>(255, brightest * options.gain);
+      uint8_t rgb[3];
+      for (uint8_t c = 0; c < 3; ++c)
+      {
+        rgb[c] = brightest == 0 ? 0 : uint8_t(crgb->raw[c] * scaledBrightest / brightest);
+      }
+
+      for (uint16_t s = 0; s < options.scale; ++s)
+      {
+        memcpy(&row[(size_t(x) * options.scale + s) * 3], rgb, 3);
+      }
+    }
+
+    // Repeat the finished row for the rest of the pixel's height.
+    for (uint16_t s = 1; s < options.scale; ++s)
+    {
+      memcpy(&row[size_t(s) * width * 3], row, size_t(width) * 3);
+    }
+  }
+
+  if (!options.raw)
+  {
+    fprintf(frameOut, "P6\n%u %u\n255\n", width, height);
+  }
+  fwrite(frameBuffer.data(), 1, frameBuffer.size(), frameOut);
+  framesWritten++;
+}
+
+void CFastLED::show()
+{
+  if (framesShown++ % options.every == 0)
+  {
+    writeFrame();
+  }
+}
+
+//////////////////////////////////////////
+// Parameters that can be swept
+
+static bool parseLong(const char *text, long minValue, long maxValue, long &value)
+{
+  char *end;
+  value = strtol(text, &end, 10);
+  return *text != '\0' && *end == '\0' && value >= minValue && value <= maxValue;
+}
+
+static bool applyInt16(const char *text, int16_t &param, long minValue, long maxValue)
+{
+  long value;
+  if (!parseLong(text, minValue, maxValue, value))
+  {
+    return false;
+  }
+  param = int16_t(value);
+  return true;
+}
+
+static bool applyMaxFps(const char *text)
+{
+  long value;
+  if (!parseLong(text, 1, 1000, value))
+  {
+    return false;
+  }
+  maxFps = value;
+  return true;
+}
+
+static bool applyGravityDirection(const char *text)
+{
+  static const char *names[GRAVITY_DIRECTION_COUNT] = {"N", "NE", "E", "SE", "S", "SW", "W", "NW"};
+  for (uint8_t d = 0; d < GRAVITY_DIRECTION_COUNT; ++d)
+  {
+    if (strcmp(text, names[d]) == 0)
+    {
+      gravityDirection = d;
+      return true;
+    }
+  }
+
+  long value;
+  if (!parseLong(text, 0, GRAVITY_DIRECTION_COUNT - 1, value))
+  {
+    return false;
+  }
+  gravityDirection = uint8_t(value);
+  return true;
+}
+
+static bool applyColorRoutine(const char *text)
+{
+  if (strcmp(text, "steps") == 0)
+    colorRoutine = setNextColor;
+  else if (strcmp(text, "sin1") == 0)
+    colorRoutine = setNextColor_sin1;
+  else if (strcmp(text, "sin2") == 0)
+    colorRoutine = setNextColor_sin2;
+  else
+    return false;
+  return true;
+}
+
+struct SweepParam
+{
+  const char *name;
+  bool (*apply)(const char *text);
+  // Empty keeps the value from main.cpp.
+  std::vector<std::string> values;
+};
+
+// Nothing can move further than across the grid in one frame. Larger values change nothing,
+// and could overflow the int16_t velocities and offsets in the simulation.
+static const long MAX_CELLS = max(ROWS, COLS);
+
+// Minimums follow what the simulation needs to keep going:
+// - gravity 0 never lands a pixel, so the grid only resets on the blocked-input fallback and
+//   most frames are a still image.
+// - percentInputFill 0 never drops a pixel.
+// - adjacentVelocityResetValue 0 is fine, a woken pixel just waits a frame for gravity.
+static SweepParam sweepParams[] = {
+    {"maxFps", applyMaxFps, {}},
+    {"maxVelocity", [](const char *text) { return applyInt16(text, maxVelocity, 1, MAX_CELLS); }, {}},
+    {"gravity", [](const char *text) { return applyInt16(text, gravity, 1, MAX_CELLS); }, {}},
+    {"adjacentVelocityResetValue", [](const char *text) { return applyInt16(text, adjacentVelocityResetValue, 0, MAX_CELLS); }, {}},
+    {"percentInputFill", [](const char *text) { return applyInt16(text, percentInputFill, 1, 100); }, {}},
+    {"inputWidth", [](const char *text) { return applyInt16(text, inputWidth, 1, MAX_CELLS); }, {}},
+    {"millisToChangeColor", [](const char *text) { return applyInt16(text, millisToChangeColor, 0, INT16_MAX); }, {}},
+    {"millisToChangeAllColors", [](const char *text) { return applyInt16(text, millisToChangeAllColors, 0, INT16_MAX); }, {}},
+    {"millisToChangeInputX", [](const char *text) { return applyInt16(text, millisToChangeInputX, 0, INT16_MAX); }, {}},
+    {"gravityDirection", applyGravityDirection, {}},
+    {"colorRoutine", applyColorRoutine, {}},
+};
+
+static const size_t SWEEP_PARAM_COUNT = sizeof(sweepParams) / sizeof(sweepParams[0]);
+
+//////////////////////////////////////////
+// Command line
+
+static void printUsage(const char *program)
+{
+  fprintf(stderr,
+          "Usage: %s [options] [--<param>=<value>[,<value>...]]...\n"
+          "\n"
+          "Options:\n"
+          "  --frames=N   frames to simulate per configuration (default 1200)\n"
+          "  --every=N    write every Nth frame, for time-lapses (default 1)\n"
+          "  --scale=N    output pixels per LED (default 8)\n"
+          "  --gain=N     brightness multiplier for the dim LED values (default 1). A pixel is only\n"
+          "               brightened until its brightest channel reaches 255, so the hue is kept\n"
+          "  --jobs=N     configurations rendered at once (default: all cores)\n"
+          "  --seed=N     random seed, the same for every configuration (default 1)\n"
+          "  --out=DIR    output directory (default .), or - to stream one configuration to stdout\n"
+          "  --raw        write raw rgb24 video instead of a stream of PPM images\n"
+          "\n"
+          "Params (comma separated values are swept):\n",
+          program);
+  for (size_t p = 0; p < SWEEP_PARAM_COUNT; ++p)
+  {
+    fprintf(stderr, "  --%s\n", sweepParams[p].name);
+  }
+  fprintf(stderr, "\nmaxVelocity, gravity, adjacentVelocityResetValue and inputWidth go up to %ld.\n"
+                  "gravity and percentInputFill (up to 100) must be at least 1.\n"
+                  "gravityDirection takes N, NE, E, SE, S, SW, W, NW or 0-7.\n"
+                  "colorRoutine takes steps, sin1 or sin2.\n",
+          MAX_CELLS);
+}
+
+static std::vector<std::string> splitList(const char *text)
+{
+  std::vector<std::string> values;
+  std::string value;
+  for (const char *c = text;; ++c)
+  {
+    if (*c == ',' || *c == '\0')
+    {
+      values.push_back(value);
+      value.clear();
+      if (*c == '\0')
+        break;
+    }
+    else
+    {
+      value += *c;
+    }
+  }
+  return values;
+}
+
+static bool parseArgs(int argc, char **argv)
+{
+  for (int a = 1; a < argc; ++a)
+  {
+    const char *arg = argv[a];
+    if (strcmp(arg, "--help") == 0)
+    {
+      printUsage(argv[0]);
+      exit(0);
+    }
+    if (strcmp(arg, "--raw") == 0)
+    {
+      options.raw = true;
+      continue;
+    }
+
+    const char *equals = strchr(arg, '=');
+    if (strncmp(arg, "--", 2) != 0 || equals == NULL)
+    {
+      fprintf(stderr, "Unexpected argument: %s\n", arg);
+      return false;
+    }
+
+    std::string name(arg + 2, equals);
+    const char *text = equals + 1;
+    long value;
+
+    if (name == "frames" && parseLong(text, 1, LONG_MAX, value))
+      options.frames = value;
+    else if (name == "every" && parseLong(text, 1, LONG_MAX, value))
+      options.every = value;
+    else if (name == "scale" && parseLong(text, 1, 64, value))
+      options.scale = uint16_t(value);
+    else if (name == "gain" && parseLong(text, 1, 255, value))
+      options.gain = uint16_t(value);
+    else if (name == "jobs" && parseLong(text, 1, 4096, value))
+      options.jobs = value;
+    else if (name == "seed" && parseLong(text, 0, UINT32_MAX, value))
+      options.seed = (unsigned int)value;
+    else if (name == "out")
+      options.out = text;
+    else
+    {
+      SweepParam *param = NULL;
+      for (size_t p = 0; p < SWEEP_PARAM_COUNT; ++p)
+      {
+        if (name == sweepParams[p].name)
+          param = &sweepParams[p];
+      }
+
+      if (param == NULL)
+      {
+        fprintf(stderr, "Invalid option: %s\n", arg);
+        return false;
+      }
+
+      // Check every value up front, so a bad sweep fails before anything is rendered.
+      param->values = splitList(text);
+      for (const std::string &v : param->values)
+      {
+        if (!param->apply(v.c_str()))
+        {
+          fprintf(stderr, "Invalid value for %s: '%s'\n", param->name, v.c_str());
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////
+// Rendering each configuration
+
+static size_t configCount()
+{
+  size_t count = 1;
+  for (size_t p = 0; p < SWEEP_PARAM_COUNT; ++p)
+  {
+    if (!sweepParams[p].values.empty())
+      count *= sweepParams[p].values.size();
+  }
+  return count;
+}
+
+// Applies configuration number index of the sweep, and returns its output file name.
+static std::string applyConfig(size_t index)
+{
+  std::string name = "sand";
+  for (size_t p = 0; p < SWEEP_PARAM_COUNT; ++p)
+  {
+    const SweepParam &param = sweepParams[p];
+    if (param.values.empty())
+      continue;
+
+    const std::string &value = param.values[index % param.values.size()];
+    index /= param.values.size();
+    param.apply(value.c_str());
+
+    // Only swept params are needed to tell the outputs apart.
+    if (param.values.size() > 1)
+      name += "_" + std::string(param.name) + "-" + value;
+  }
+  return name + (options.raw ? ".rgb" : ".ppm");
+}
+
+// Runs in its own process, so it can use the simulation's globals freely.
+static int renderConfig(size_t index)
+{
+  std::string fileName = applyConfig(index);
+  std::string path = options.out == "-" ? "stdout" : options.out + "/" + fileName;
+
+  frameOut = options.out == "-" ? stdout : fopen(path.c_str(), "wb");
+  if (frameOut == NULL)
+  {
+    fprintf(stderr, "Could not open %s\n", path.c_str());
+    return 1;
+  }
+  static char outBuffer[1 << 16];
+  setvbuf(frameOut, outBuffer, _IOFBF, sizeof(outBuffer));
+
+  srand(options.seed);
+  setup();
+
+  // Tick the clock 1 ms at a time, the same as loop() sees on hardware, so the
+  // color change timers fire between frames as they would there.
+  while (framesShown < options.frames)
+  {
+    virtualMillis++;
+    loop();
+  }
+
+  if (fclose(frameOut) != 0)
+  {
+    fprintf(stderr, "Could not write %s\n", path.c_str());
+    return 1;
+  }
+
+  fprintf(stderr, "%s: %lu frames, %ux%u%s\n", path.c_str(), framesWritten,
+          COLS * options.scale, ROWS * options.scale, options.raw ? " rgb24" : "");
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  if (!parseArgs(argc, argv))
+  {
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  size_t count = configCount();
+  if (options.out == "-" && count > 1)
+  {
+    fprintf(stderr, "Only one configuration can be streamed to stdout, but %zu were given.\n", count);
+    return 2;
+  }
+
+  long jobs = options.jobs > 0 ? options.jobs : max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+  auto startTime = std::chrono::steady_clock::now();
+
+  // Make sure nothing buffered is written twice by the forked children.
+  fflush(stdout);
+  fflush(stderr);
+
+  long running = 0;
+  size_t failed = 0;
+  for (size_t index = 0; index < count || running > 0;)
+  {
+    if (index < count && running < jobs)
+    {
+      pid_t pid = fork();
+      if (pid == 0)
+      {
+        _exit(renderConfig(index));
+      }
+      if (pid < 0)
+      {
+        perror("fork");
+        failed += count - index;
+        index = count;
+        continue;
+      }
+      running++;
+      index++;
+      continue;
+    }
+
+    int status;
+    if (wait(&status) < 0)
+    {
+      perror("wait");
+      return 1;
+    }
+    running--;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+      failed++;
+    }
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  fprintf(stderr, "Rendered %zu configuration(s) of %lu frames in %.2f s on %ld job(s)%s.\n",
+          count - failed, options.frames, seconds, jobs, failed ? ", some failed" : "");
+
+  return failed ? 1 : 0;
+}
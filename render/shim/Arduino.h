@@ -0,0 +1,36 @@
+// Host stand-in for the parts of the Arduino core used by src/, so the sand
+// simulation can run headless in the offline renderer.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+typedef uint8_t byte;
+
+using std::max;
+using std::min;
+
+// Provided by the renderer, which drives a virtual clock.
+unsigned long millis();
+
+inline long random(long howBig)
+{
+  return howBig > 0 ? rand() % howBig : 0;
+}
+
+inline long random(long howSmall, long howBig)
+{
+  return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+// Serial output is dropped, so stdout can carry frames.
+struct HostSerial
+{
+  void begin(unsigned long) {}
+  void println(const char *) {}
+  template <typename... Args>
+  void printf(const char *, Args...) {}
+};
+
+static HostSerial Serial;
@@ -0,0 +1,36 @@
+// Host stand-in for the parts of FastLED used by src/. show() hands the LED
+// buffer to the offline renderer instead of driving a data pin.
+#pragma once
+
+#include <cstdint>
+
+struct CRGB
+{
+  union
+  {
+    struct
+    {
+      uint8_t r;
+      uint8_t g;
+      uint8_t b;
+    };
+    uint8_t raw[3];
+  };
+};
+
+template <uint8_t DATA_PIN>
+class NEOPIXEL
+{
+};
+
+class CFastLED
+{
+public:
+  template <template <uint8_t DATA_PIN> class CHIPSET, uint8_t DATA_PIN>
+  void addLeds(CRGB *, int) {}
+
+  // Provided by the renderer.
+  void show();
+};
+
+static CFastLED FastLED;
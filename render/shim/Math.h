@@ -0,0 +1,4 @@
+// Host stand-in for <Math.h>, which only exists on case-insensitive toolchains.
+#pragma once
+
+#include <math.h>
@@ -33,7 +33,7 @@ void setNextColor_sin1(byte *rgbValues, uint16_t &kValue)
     rgbValues[0] = sins1[kValue];
     rgbValues[1] = sins1[(kValue + 120) % 360];
     rgbValues[2] = sins1[(kValue + 240) % 360];
-    kValue++;
+    kValue = (kValue + 1) % 360;
 }
 
 void setNextColor_sin2(byte *rgbValues, uint16_t &kValue)
@@ -41,7 +41,7 @@ void setNextColor_sin2(byte *rgbValues, uint16_t &kValue)
     rgbValues[0] = sins2[(kValue + 120) % 360];
     rgbValues[1] = sins2[kValue];
     rgbValues[2] = sins2[(kValue + 240) % 360];
-    kValue++;
+    kValue = (kValue + 1) % 360;
 }
 
 // Color changing state machine
@@ -3,6 +3,17 @@
 #include "FastLED.h"
 #include "colorChangeRoutine.h"
 
+// Gravity directions, as compass points on the display (N is the top row).
+static const uint8_t GRAVITY_DIRECTION_N = 0;
+static const uint8_t GRAVITY_DIRECTION_NE = 1;
+static const uint8_t GRAVITY_DIRECTION_E = 2;
+static const uint8_t GRAVITY_DIRECTION_SE = 3;
+static const uint8_t GRAVITY_DIRECTION_S = 4;
+static const uint8_t GRAVITY_DIRECTION_SW = 5;
+static const uint8_t GRAVITY_DIRECTION_W = 6;
+static const uint8_t GRAVITY_DIRECTION_NW = 7;
+static const uint8_t GRAVITY_DIRECTION_COUNT = 8;
+
 //////////////////////////////////////////
 // Parameters you can play with:
 
@@ -23,6 +34,12 @@ int16_t maxVelocity = 2;
 int16_t gravity = 1;
 int16_t adjacentVelocityResetValue = 3;
 
+// The direction the pixels fall. Can be changed at runtime with setGravityDirection().
+uint8_t gravityDirection = GRAVITY_DIRECTION_S;
+
+// Color routine from colorChangeRoutine.h: setNextColor, setNextColor_sin1 or setNextColor_sin2.
+void (*colorRoutine)(byte *rgbValues, uint16_t &kValue) = setNextColor;
+
 // End parameters you can play with
 //////////////////////////////////////////
 
@@ -33,8 +50,10 @@ const bool perPanelIsVertical = false;
 //////////////////////////////////////////
 // Display size parameters:
 
+#if !defined(LED_PANELS_1) && !defined(LED_PANELS_9_16x16)
 #define LED_PANELS_1
 // #define LED_PANELS_9_16x16
+#endif
 
 #ifdef LED_PANELS_1
 static const uint16_t ROWS = 16;
@@ -66,6 +85,8 @@ struct GridState
   uint16_t state;
   uint16_t kValue;
   int16_t velocity;
+  // gravityEpoch when this pixel landed.
+  uint8_t settleEpoch;
 };
 
 #ifndef LED_DATA_PIN_PANEL_1
@@ -82,14 +103,17 @@ struct GridState
 
 CRGB *leds;
 
-int16_t dropCount = 0;
-
 unsigned long lastMillis;
 unsigned long colorChangeTime = 0;
 unsigned long allColorChangeTime = 0;
 
 unsigned long inputXChangeTime = 0;
 
+// Frames in a row the input cell held a pixel from an earlier frame, with no pixel moving or landing.
+uint16_t blockedInputFrames = 0;
+// Whether the last frame added a pixel at the input cell.
+bool inputSpawned = false;
+
 int16_t BACKGROUND_COLOR = COLOR_BLACK;
 
 byte rgbValues[] = {0x31, 0x00, 0x00}; // red, green, blue
@@ -108,6 +132,59 @@ static const uint16_t GRID_STATE_NEW = 1;
 static const uint16_t GRID_STATE_FALLING = 2;
 static const uint16_t GRID_STATE_COMPLETE = 3;
 
+// Per-lane (column or row) count of landed pixels, kept up to date as pixels land and wake.
+// A lane is open for new pixels until every cell in it has landed.
+// The counts don't depend on the gravity direction, so they stay exact when it changes.
+struct LaneIndex
+{
+  uint16_t laneCount;
+  uint16_t laneLength;
+  // Landed pixels in each lane.
+  uint16_t *fill;
+  // Lanes that are not full, in no particular order.
+  uint16_t *open;
+  uint16_t openCount;
+  // Position of each lane in open, or LANE_FULL.
+  uint16_t *openPos;
+};
+
+static const uint16_t LANE_FULL = 0xFFFF;
+
+// Both indexes are always maintained, so either can be used after the gravity direction changes.
+LaneIndex colLanes;
+LaneIndex rowLanes;
+
+// Precomputed tables for one gravity direction, so the fall pass never has to
+// check the orientation per pixel. Switching direction is just a pointer swap.
+struct GravityDirection
+{
+  // Offset of the cell straight "below".
+  int8_t dx;
+  int8_t dy;
+  // Offsets of the two cells diagonally "below" (the down offset rotated +/- 45 degrees).
+  int8_t sideDx[2];
+  int8_t sideDy[2];
+  // Every cell index (y * COLS + x), ordered from the "top" of the display to the "bottom".
+  uint16_t *scanOrder;
+  // The edge new pixels are added along: the first cell and the step between cells (one per lane).
+  int16_t spawnX;
+  int16_t spawnY;
+  int8_t spawnStepX;
+  int8_t spawnStepY;
+  // The lanes new pixels are added to.
+  LaneIndex *lanes;
+};
+
+// Compass offsets, clockwise from N, indexed by GRAVITY_DIRECTION_*.
+static const int8_t compassDx[GRAVITY_DIRECTION_COUNT] = {0, 1, 1, 1, 0, -1, -1, -1};
+static const int8_t compassDy[GRAVITY_DIRECTION_COUNT] = {-1, -1, 0, 1, 1, 1, 0, -1};
+
+GravityDirection gravityDirections[GRAVITY_DIRECTION_COUNT];
+GravityDirection *gravityDir;
+
+// Bumped on every gravity change, so pixels that landed under the old gravity fall again.
+uint8_t gravityEpoch = 0;
+
 // XY function from:
 // https://github.com/FastLED/FastLED/blob/master/examples/XYMatrix/XYMatrix.ino
 // then modified here.
@@ -206,7 +283,7 @@ CRGB *getCrgb(uint16_t xCol, uint16_t yRow)
 void setNextColor(uint16_t xCol, uint16_t yRow, uint16_t &kValue)
 {
   CRGB *crgb = getCrgb(xCol, yRow);
-  setNextColor(crgb->raw, kValue);
+  colorRoutine(crgb->raw, kValue);
 }
 
 bool withinCols(int16_t value)
@@ -234,62 +311,84 @@ void setNextColorAll()
   }
 }
 
-void resetAdjacentPixels(int16_t x, int16_t y)
+void setupLaneIndex(LaneIndex &lanes, uint16_t laneCount, uint16_t laneLength)
 {
-  int16_t xPlus = x + 1;
-  int16_t xMinus = x - 1;
-  int16_t yPlus = y + 1;
-  int16_t yMinus = y - 1;
+  lanes.laneCount = laneCount;
+  lanes.laneLength = laneLength;
+  lanes.fill = new uint16_t[laneCount];
+  lanes.open = new uint16_t[laneCount];
+  lanes.openPos = new uint16_t[laneCount];
+}
 
-  // Row above
-  if (withinRows(yMinus))
+void resetLaneIndex(LaneIndex &lanes)
+{
+  for (uint16_t lane = 0; lane < lanes.laneCount; ++lane)
   {
-    if (nextStateGrid[yMinus][xMinus].state == GRID_STATE_COMPLETE)
-    {
-      nextStateGrid[yMinus][xMinus].state = GRID_STATE_FALLING;
-      nextStateGrid[yMinus][xMinus].velocity = adjacentVelocityResetValue;
-    }
-    if (nextStateGrid[yMinus][x].state == GRID_STATE_COMPLETE)
-    {
-      nextStateGrid[yMinus][x].state = GRID_STATE_FALLING;
-      nextStateGrid[yMinus][x].velocity = adjacentVelocityResetValue;
-    }
-    if (nextStateGrid[yMinus][xPlus].state == GRID_STATE_COMPLETE)
-    {
-      nextStateGrid[yMinus][xPlus].state = GRID_STATE_FALLING;
-      nextStateGrid[yMinus][xPlus].velocity = adjacentVelocityResetValue;
-    }
+    lanes.fill[lane] = 0;
+    lanes.open[lane] = lane;
+    lanes.openPos[lane] = lane;
   }
+  lanes.openCount = lanes.laneCount;
+}
 
-  // Current row
-  if (nextStateGrid[y][xMinus].state == GRID_STATE_COMPLETE)
+void laneSettled(LaneIndex &lanes, uint16_t lane)
+{
+  if (++lanes.fill[lane] < lanes.laneLength)
   {
-    nextStateGrid[y][xMinus].state = GRID_STATE_FALLING;
-    nextStateGrid[y][xMinus].velocity = adjacentVelocityResetValue;
+    return;
   }
-  if (nextStateGrid[y][xPlus].state == GRID_STATE_COMPLETE)
+
+  // Lane is full, swap-remove it from the open list.
+  uint16_t pos = lanes.openPos[lane];
+  uint16_t lastLane = lanes.open[--lanes.openCount];
+  lanes.open[pos] = lastLane;
+  lanes.openPos[lastLane] = pos;
+  lanes.openPos[lane] = LANE_FULL;
+}
+
+void laneWoken(LaneIndex &lanes, uint16_t lane)
+{
+  if (lanes.fill[lane]-- < lanes.laneLength)
   {
-    nextStateGrid[y][xPlus].state = GRID_STATE_FALLING;
-    nextStateGrid[y][xPlus].velocity = adjacentVelocityResetValue;
+    return;
   }
 
-  // Row below
-  if (withinRows(yPlus))
+  // Lane was full, add it back to the open list.
+  lanes.open[lanes.openCount] = lane;
+  lanes.openPos[lane] = lanes.openCount++;
+}
+
+// A pixel at x, y has landed (its state became GRID_STATE_COMPLETE).
+void markSettled(int16_t x, int16_t y)
+{
+  laneSettled(colLanes, x);
+  laneSettled(rowLanes, y);
+
+  // The pile is still changing, so the input isn't stuck.
+  blockedInputFrames = 0;
+}
+
+// A landed pixel at x, y is no longer GRID_STATE_COMPLETE.
+void markWoken(int16_t x, int16_t y)
+{
+  laneWoken(colLanes, x);
+  laneWoken(rowLanes, y);
+}
+
+void resetAdjacentPixels(int16_t x, int16_t y)
+{
+  // Wake up every landed neighbor, in all 8 directions.
+  for (uint8_t d = 0; d < GRAVITY_DIRECTION_COUNT; ++d)
   {
-    if (nextStateGrid[yPlus][xMinus].state == GRID_STATE_COMPLETE)
-    {
-      nextStateGrid[yPlus][xMinus].state = GRID_STATE_FALLING;
-      nextStateGrid[yPlus][xMinus].velocity = adjacentVelocityResetValue;
-    }
-    if (nextStateGrid[yPlus][x].state == GRID_STATE_COMPLETE)
-    {
-      nextStateGrid[yPlus][x].state = GRID_STATE_FALLING;
-      nextStateGrid[yPlus][x].velocity = adjacentVelocityResetValue;
-    }
-    if (nextStateGrid[yPlus][xPlus].state == GRID_STATE_COMPLETE)
+    int16_t xAdjacent = x + compassDx[d];
+    int16_t yAdjacent = y + compassDy[d];
+
+    if (withinCols(xAdjacent) && withinRows(yAdjacent) &&
+        nextStateGrid[yAdjacent][xAdjacent].state == GRID_STATE_COMPLETE)
     {
-      nextStateGrid[yPlus][xPlus].state = GRID_STATE_FALLING;
-      nextStateGrid[yPlus][xPlus].velocity = adjacentVelocityResetValue;
+      nextStateGrid[yAdjacent][xAdjacent].state = GRID_STATE_FALLING;
+      nextStateGrid[yAdjacent][xAdjacent].velocity = adjacentVelocityResetValue;
+      markWoken(xAdjacent, yAdjacent);
     }
   }
 }
@@ -310,6 +409,63 @@ void setColor(CRGB *crgb, int8_t _red, int8_t _green, int8_t _blue)
   crgb->raw[2] = _blue;  /// * `raw[2]` is the blue value
 }
 
+void setupGravityDirections()
+{
+  for (uint8_t d = 0; d < GRAVITY_DIRECTION_COUNT; ++d)
+  {
+    GravityDirection &g = gravityDirections[d];
+    g.dx = compassDx[d];
+    g.dy = compassDy[d];
+    g.sideDx[0] = compassDx[(d + 1) % GRAVITY_DIRECTION_COUNT];
+    g.sideDy[0] = compassDy[(d + 1) % GRAVITY_DIRECTION_COUNT];
+    g.sideDx[1] = compassDx[(d + GRAVITY_DIRECTION_COUNT - 1) % GRAVITY_DIRECTION_COUNT];
+    g.sideDy[1] = compassDy[(d + GRAVITY_DIRECTION_COUNT - 1) % GRAVITY_DIRECTION_COUNT];
+
+    // Scan "upstream" cells first, the same way the original +y pass scanned top-to-bottom.
+    // Rows are the outer loop unless gravity is purely horizontal.
+    bool rowsOuter = g.dy != 0;
+    int16_t outerCount = rowsOuter ? ROWS : COLS;
+    int16_t innerCount = rowsOuter ? COLS : ROWS;
+    bool outerReversed = rowsOuter ? g.dy < 0 : g.dx < 0;
+    bool innerReversed = rowsOuter ? g.dx < 0 : false;
+
+    g.scanOrder = new uint16_t[NUM_LEDS];
+    uint16_t n = 0;
+    for (int16_t o = 0; o < outerCount; ++o)
+    {
+      int16_t outer = outerReversed ? outerCount - 1 - o : o;
+      for (int16_t k = 0; k < innerCount; ++k)
+      {
+        int16_t inner = innerReversed ? innerCount - 1 - k : k;
+        int16_t x = rowsOuter ? inner : outer;
+        int16_t y = rowsOuter ? outer : inner;
+        g.scanOrder[n++] = y * COLS + x;
+      }
+    }
+
+    // New pixels enter along the edge opposite to the direction they fall.
+    g.spawnX = rowsOuter ? 0 : (g.dx > 0 ? 0 : COLS - 1);
+    g.spawnY = rowsOuter ? (g.dy > 0 ? 0 : ROWS - 1) : 0;
+    g.spawnStepX = rowsOuter ? 1 : 0;
+    g.spawnStepY = rowsOuter ? 0 : 1;
+
+    g.lanes = rowsOuter ? &colLanes : &rowLanes;
+  }
+}
+
+void setGravityDirection(uint8_t direction)
+{
+  gravityDirection = direction % GRAVITY_DIRECTION_COUNT;
+  gravityDir = &gravityDirections[gravityDirection];
+  gravityEpoch++;
+
+  // Move the input to the new "top" edge on the next frame. That edge may still hold the old pile,
+  // which is about to fall away, so don't count it as blocked input.
+  inputXChangeTime = 0;
+  blockedInputFrames = 0;
+  inputSpawned = false;
+}
+
 void resetGrid()
 {
   // Serial.println("Initial values....");
@@ -331,6 +487,11 @@ void resetGrid()
       lastStateGrid[i][j].kValue = 0;
     }
   }
+
+  resetLaneIndex(colLanes);
+  resetLaneIndex(rowLanes);
+  blockedInputFrames = 0;
+  inputSpawned = false;
 }
 
 void setupFastLED_1_Panel()
@@ -375,6 +536,11 @@ void setup()
   setupFastLED_3_Panels_16x48();
 #endif
 
+  setupLaneIndex(colLanes, COLS, ROWS);
+  setupLaneIndex(rowLanes, ROWS, COLS);
+  setupGravityDirections();
+  setGravityDirection(gravityDirection);
+
   // Initial values
   resetGrid();
 
@@ -391,7 +557,7 @@ void loop()
   if (colorChangeTime < millis())
   {
     colorChangeTime = millis() + millisToChangeColor;
-    setNextColor(rgbValues, newKValue);
+    colorRoutine(rgbValues, newKValue);
   }
 
   // Change the color of the fallen pixels over time
@@ -412,11 +578,50 @@ void loop()
   lastMillis = currentMillis;
   // Serial.println("Looping within FPS limit...");
 
-  // Change the inputX of the pixels over time or if the current input is already filled.
-  if (inputXChangeTime < millis() || stateGrid[inputY][inputX].state != GRID_STATE_NONE)
+  LaneIndex *lanes = gravityDir->lanes;
+
+  bool inputBlocked = stateGrid[inputY][inputX].state != GRID_STATE_NONE;
+  if (!inputBlocked)
+  {
+    blockedInputFrames = 0;
+  }
+  else if (!inputSpawned)
+  {
+    blockedInputFrames++;
+  }
+  inputSpawned = false;
+
+  // Start over once every lane has filled up with landed pixels.
+  // Pixels that never land (e.g. with gravity = 0) keep their lanes open with no room left,
+  // so also start over once the input cell has held an older pixel for as many frames as there
+  // are lanes, with no pixel moving or landing anywhere in the meantime. Each of those frames
+  // moves the input to a different open lane (not necessarily visiting every lane).
+  if (lanes->openCount == 0 || blockedInputFrames >= lanes->laneCount)
+  {
+    resetGrid();
+  }
+
+  // Change the inputX of the pixels over time, or if the current input lane is already filled or blocked.
+  int16_t inputLane = inputX * gravityDir->spawnStepX + inputY * gravityDir->spawnStepY;
+  if (inputXChangeTime < millis() || lanes->openPos[inputLane] == LANE_FULL || inputBlocked)
   {
     inputXChangeTime = millis() + millisToChangeInputX;
-    inputX = random(0, COLS);
+
+    // Pick a different open lane when there is one. Leave the last open slot out of the draw,
+    // and take it in place of the current lane if that is drawn.
+    uint16_t inputOpenPos = lanes->openPos[inputLane];
+    int16_t spawnPos;
+    if (inputOpenPos != LANE_FULL && lanes->openCount > 1)
+    {
+      uint16_t pick = random(0, lanes->openCount - 1);
+      spawnPos = lanes->open[pick == inputOpenPos ? lanes->openCount - 1 : pick];
+    }
+    else
+    {
+      spawnPos = lanes->open[random(0, lanes->openCount)];
+    }
+    inputX = gravityDir->spawnX + spawnPos * gravityDir->spawnStepX;
+    inputY = gravityDir->spawnY + spawnPos * gravityDir->spawnStepY;
   }
 
   // Randomly add an area of pixels
@@ -427,19 +632,14 @@ void loop()
     {
       if (random(100) < percentInputFill)
       {
-        dropCount++;
-        if (dropCount > (inputWidth * ROWS * COLS))
-        {
-          dropCount = 0;
-          resetGrid();
-        }
-
         int16_t col = inputX + i;
         int16_t row = inputY + j;
 
-        if (withinCols(col) && withinRows(row) &&
-            (stateGrid[row][col].state == GRID_STATE_NONE || stateGrid[row][col].state == GRID_STATE_COMPLETE))
+        // Only add pixels to empty cells. Replacing landed ones would keep reopening full lanes.
+        if (withinCols(col) && withinRows(row) && stateGrid[row][col].state == GRID_STATE_NONE)
         {
+          inputSpawned = inputSpawned || (col == inputX && row == inputY);
+
           setColor(getCrgb(col, row), COLORS_ARRAY_RED, COLORS_ARRAY_GREEN, COLORS_ARRAY_BLUE);
           stateGrid[row][col].state = GRID_STATE_NEW;
           stateGrid[row][col].velocity = 1;
@@ -483,128 +683,107 @@ void loop()
   // unsigned long beforeCheckEveryCell = millis();
   // unsigned long pixelsChecked = 0;
   // Check every pixel to see which need moving, and move them.
-  for (int16_t i = 0; i < ROWS; ++i)
+  // The cells are visited in the precomputed order for the current gravity direction.
+  const int16_t downX = gravityDir->dx;
+  const int16_t downY = gravityDir->dy;
+  const uint16_t *scanOrder = gravityDir->scanOrder;
+  for (uint16_t n = 0; n < NUM_LEDS; ++n)
   {
-    for (int16_t j = 0; j < COLS; ++j)
-    {
-      // This nexted loop is where the bulk of the computations occur.
-      // Tread lightly in here, and check as few pixels as needed.
-
-      // Get the state of the current pixel.
-      CRGB pixelColor = *getCrgb(j, i);
-      uint16_t pixelState = stateGrid[i][j].state;
-      int16_t pixelVelocity = stateGrid[i][j].velocity;
-      uint16_t pixelKValue = stateGrid[i][j].kValue;
+    // This loop is where the bulk of the computations occur.
+    // Tread lightly in here, and check as few pixels as needed.
+    int16_t i = scanOrder[n] / COLS;
+    int16_t j = scanOrder[n] % COLS;
 
-      bool moved = false;
+    // Get the state of the current pixel.
+    CRGB pixelColor = *getCrgb(j, i);
+    uint16_t pixelState = stateGrid[i][j].state;
+    int16_t pixelVelocity = stateGrid[i][j].velocity;
+    uint16_t pixelKValue = stateGrid[i][j].kValue;
 
-      // If the current pixel has landed, no need to keep checking for its next move.
-      if (pixelState != GRID_STATE_NONE && pixelState != GRID_STATE_COMPLETE)
-      {
-        // pixelsChecked++;
+    bool moved = false;
 
-        int16_t newPos = int16_t(i + min(maxVelocity, pixelVelocity));
-        for (int16_t y = newPos; y > i; y--)
-        {
-          if (!withinRows(y))
-          {
-            continue;
-          }
-
-          GridState belowState = stateGrid[y][j];
-          GridState belowNextState = nextStateGrid[y][j];
+    // Landed under a different gravity, so check it again like a woken pixel.
+    if (pixelState == GRID_STATE_COMPLETE && stateGrid[i][j].settleEpoch != gravityEpoch)
+    {
+      pixelState = GRID_STATE_FALLING;
+      pixelVelocity = adjacentVelocityResetValue;
+      markWoken(j, i);
+    }
 
-          int16_t direction = 1;
-          if (random(100) < 50)
-          {
-            direction *= -1;
-          }
+    // If the current pixel has landed, no need to keep checking for its next move.
+    if (pixelState != GRID_STATE_NONE && pixelState != GRID_STATE_COMPLETE)
+    {
+      // pixelsChecked++;
 
-          GridState *belowStateA = NULL;
-          GridState *belowNextStateA = NULL;
-          GridState *belowStateB = NULL;
-          GridState *belowNextStateB = NULL;
+      int16_t steps = min(maxVelocity, pixelVelocity);
+      for (int16_t step = steps; step > 0 && !moved; step--)
+      {
+        // The cell one step short of the target, from which to go straight down or to either side.
+        int16_t baseX = j + (step - 1) * downX;
+        int16_t baseY = i + (step - 1) * downY;
+
+        int16_t side = random(100) < 50 ? 0 : 1;
+
+        // Straight down first, then side A, then side B.
+        int16_t candidateX[3] = {
+            int16_t(baseX + downX),
+            int16_t(baseX + gravityDir->sideDx[side]),
+            int16_t(baseX + gravityDir->sideDx[1 - side])};
+        int16_t candidateY[3] = {
+            int16_t(baseY + downY),
+            int16_t(baseY + gravityDir->sideDy[side]),
+            int16_t(baseY + gravityDir->sideDy[1 - side])};
+
+        for (uint8_t c = 0; c < 3; ++c)
+        {
+          int16_t x = candidateX[c];
+          int16_t y = candidateY[c];
 
-          if (withinCols(j + direction))
+          if (!withinCols(x) || !withinRows(y))
           {
-            belowStateA = &stateGrid[y][j + direction];
-            belowNextStateA = &nextStateGrid[y][j + direction];
-          }
-          if (withinCols(j - direction))
-          {
-            belowStateB = &stateGrid[y][j - direction];
-            belowNextStateB = &nextStateGrid[y][j - direction];
+            continue;
           }
 
-          if (belowState.state == GRID_STATE_NONE && belowNextState.state == GRID_STATE_NONE)
-          {
-            // This pixel will go straight down.
-            // leds[getPanelXYOffset(j, y)] = pixelColor;
-            CRGB *crgb = getCrgb(j, y);
-            // TODO: VERIFY THIS WORKS or use: *crgb = pixelColor;:
-            // TODO: VERIFY THIS WORKS or use: *crgb = pixelColor;:
-            // TODO: VERIFY THIS WORKS or use: *crgb = pixelColor;:
-            crgb[0] = pixelColor;
-            nextStateGrid[y][j].state = GRID_STATE_FALLING;
-            nextStateGrid[y][j].velocity = pixelVelocity + gravity;
-            nextStateGrid[y][j].kValue = pixelKValue;
-            moved = true;
-            break;
-          }
-          else if ((belowStateA != NULL && belowStateA->state == GRID_STATE_NONE) && (belowNextStateA != NULL && belowNextStateA->state == GRID_STATE_NONE))
+          if (stateGrid[y][x].state == GRID_STATE_NONE && nextStateGrid[y][x].state == GRID_STATE_NONE)
           {
-            // This pixel will fall to side A (right)
-            // leds[getPanelXYOffset(j + direction, y)] = pixelColor;
-            CRGB *crgb = getCrgb(j + direction, y);
-            // TODO: VERIFY THIS WORKS or use: *crgb = pixelColor;:
-            // TODO: VERIFY THIS WORKS or use: *crgb = pixelColor;:
-            // TODO: VERIFY THIS WORKS or use: *crgb = pixelColor;:
-            crgb[0] = pixelColor;
-            nextStateGrid[y][j + direction].state = GRID_STATE_FALLING;
-            nextStateGrid[y][j + direction].velocity = pixelVelocity + gravity;
-            nextStateGrid[y][j + direction].kValue = pixelKValue;
-            moved = true;
-            break;
-          }
-          else if ((belowStateB != NULL && belowStateB->state == GRID_STATE_NONE) && (belowNextStateB != NULL && belowNextStateB->state == GRID_STATE_NONE))
-          {
-            // This pixel will fall to side B (left)
-            // leds[getPanelXYOffset(j - direction, y)] = pixelColor;
-            CRGB *crgb = getCrgb(j - direction, y);
-            // TODO: VERIFY THIS WORKS or use: *crgb = pixelColor;:
-            // TODO: VERIFY THIS WORKS or use: *crgb = pixelColor;:
-            // TODO: VERIFY THIS WORKS or use: *crgb = pixelColor;:
-            crgb[0] = pixelColor;
-            nextStateGrid[y][j - direction].state = GRID_STATE_FALLING;
-            nextStateGrid[y][j - direction].velocity = pixelVelocity + gravity;
-            nextStateGrid[y][j - direction].kValue = pixelKValue;
+            *getCrgb(x, y) = pixelColor;
+            nextStateGrid[y][x].state = GRID_STATE_FALLING;
+            nextStateGrid[y][x].velocity = pixelVelocity + gravity;
+            nextStateGrid[y][x].kValue = pixelKValue;
             moved = true;
             break;
           }
         }
       }
+    }
 
-      if (moved)
-      {
-        // Reset color where this pixel was.
-        // setColor(&leds[getPanelXYOffset(j, i)], 0, 0, 0);
-        setColor(getCrgb(j, i), 0, 0, 0);
+    if (moved)
+    {
+      // Reset color where this pixel was.
+      // setColor(&leds[getPanelXYOffset(j, i)], 0, 0, 0);
+      setColor(getCrgb(j, i), 0, 0, 0);
 
-        resetAdjacentPixels(j, i);
-      }
+      resetAdjacentPixels(j, i);
+
+      // The pile is still changing, so the input isn't stuck.
+      blockedInputFrames = 0;
+    }
 
-      if (pixelState != GRID_STATE_NONE && !moved)
+    if (pixelState != GRID_STATE_NONE && !moved)
+    {
+      nextStateGrid[i][j].velocity = pixelVelocity + gravity;
+      nextStateGrid[i][j].kValue = pixelKValue;
+      nextStateGrid[i][j].settleEpoch = gravityEpoch;
+
+      if (pixelState == GRID_STATE_NEW)
+        nextStateGrid[i][j].state = GRID_STATE_FALLING;
+      else if (pixelState == GRID_STATE_FALLING && pixelVelocity > 2)
       {
-        nextStateGrid[i][j].velocity = pixelVelocity + gravity;
-        nextStateGrid[i][j].kValue = pixelKValue;
-
-        if (pixelState == GRID_STATE_NEW)
-          nextStateGrid[i][j].state = GRID_STATE_FALLING;
-        else if (pixelState == GRID_STATE_FALLING && pixelVelocity > 2)
-          nextStateGrid[i][j].state = GRID_STATE_COMPLETE;
-        else
-          nextStateGrid[i][j].state = pixelState; // should be GRID_STATE_COMPLETE
+        nextStateGrid[i][j].state = GRID_STATE_COMPLETE;
+        markSettled(j, i);
       }
+      else
+        nextStateGrid[i][j].state = pixelState; // should be GRID_STATE_COMPLETE
     }
   }
   // unsigned long afterCheckEveryCell = millis();